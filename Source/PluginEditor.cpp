@@ -16,33 +16,43 @@ TukTukyAudioProcessorEditor::TukTukyAudioProcessorEditor (TukTukyAudioProcessor&
     delaySyncSlider(*audioProcessor.apvts.getParameter("Delay Sync")),
     feedbackSlider(*audioProcessor.apvts.getParameter("Feedback")),
     mixSlider(*audioProcessor.apvts.getParameter("Mix")),
+    morphSlider(*audioProcessor.apvts.getParameter("Morph")),
     delaySliderAttachment(audioProcessor.apvts, "Delay", delaySlider),
     delaySyncSliderAttachment(audioProcessor.apvts, "Delay Sync", delaySyncSlider),
     feedbackSliderAttachment(audioProcessor.apvts, "Feedback", feedbackSlider),
-    mixSliderAttachment(audioProcessor.apvts, "Mix", mixSlider)
+    mixSliderAttachment(audioProcessor.apvts, "Mix", mixSlider),
+    morphSliderAttachment(audioProcessor.apvts, "Morph", morphSlider)
 {
 
     delaySlider.setMarks({"0.1s", "2s"});
     delaySyncSlider.setMarks({"1/16", "1/8", "1/6", "1/4", "1/3", "1/2", "1"});
     feedbackSlider.setMarks({"0", "1"});
     mixSlider.setMarks({"0", "1"});
+    morphSlider.setMarks({"0s", "2s"});
 
     syncButton.setButtonText("Sync");
     pingPongButton.setButtonText("PingPong");
+    freezeButton.setButtonText("Freeze");
+    abButton.setButtonText("A/B");
     syncButton.onClick = [this]() { syncClicked(); };
     pingPongButton.onClick = [this]() { pingPongClicked(); };
+    freezeButton.onClick = [this]() { freezeClicked(); };
+    abButton.onClick = [this]() { abClicked(); };
     // Make all comps visible
     for (auto* comp : getComps()) {
         addAndMakeVisible(comp);
     }
 
-    delaySyncSlider.setVisible(false);
+    // Modes may have been restored from a saved state
+    refreshButtons();
+    audioProcessor.addChangeListener(this);
     // Set size
     setSize (600, 300);
 }
 
 TukTukyAudioProcessorEditor::~TukTukyAudioProcessorEditor()
 {
+    audioProcessor.removeChangeListener(this);
 }
 
 //==============================================================================
@@ -87,11 +97,18 @@ void TukTukyAudioProcessorEditor::resized()
     pArea.removeFromLeft(toggleHeight).removeFromRight(toggleHeight);
     auto pingArea = pArea.removeFromLeft(pArea.getWidth() * 0.5);
     pingPongButton.setBounds(pingArea.withHeight(toggleHeight).withY(pingArea.getY() + (pingArea.getHeight() - toggleHeight) / 2));
+    abButton.setBounds(pArea.withHeight(toggleHeight).withY(pArea.getY() + (pArea.getHeight() - toggleHeight) / 2));
     setLabel(feedbackLabel, "FEEDBACK", secondArea.removeFromTop(secondArea.getHeight() * 0.3));
     feedbackSlider.setBounds(secondArea);
 
     // AREA 3/3
-    bounds.removeFromBottom(bounds.getHeight() * 0.25);
+    auto fArea = bounds.removeFromBottom(bounds.getHeight() * 0.25);
+
+    fArea.removeFromLeft(toggleHeight).removeFromRight(toggleHeight);
+    auto freezeArea = fArea.removeFromLeft(fArea.getWidth() * 0.5);
+    freezeButton.setBounds(freezeArea.withHeight(toggleHeight).withY(freezeArea.getY() + (freezeArea.getHeight() - toggleHeight) / 2));
+    setLabel(morphLabel, "MORPH", fArea.removeFromTop(fArea.getHeight() * 0.3));
+    morphSlider.setBounds(fArea);
     setLabel(mixLabel, "MIX", bounds.removeFromTop(bounds.getHeight() * 0.3));
     mixSlider.setBounds(bounds);
 
@@ -107,11 +124,15 @@ std::vector<juce::Component*> TukTukyAudioProcessorEditor::getComps()
         &delaySyncSlider,
         &feedbackSlider,
         &mixSlider,
+        &morphSlider,
         &delayLabel,
         &feedbackLabel,
         &mixLabel,
+        &morphLabel,
         &syncButton,
         &pingPongButton,
+        &freezeButton,
+        &abButton,
     };
 }
 
@@ -15,7 +15,8 @@
 //==============================================================================
 /**
 */
-class TukTukyAudioProcessorEditor  : public juce::AudioProcessorEditor
+class TukTukyAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                     private juce::ChangeListener
 {
 public:
     TukTukyAudioProcessorEditor (TukTukyAudioProcessor&);
@@ -37,7 +38,8 @@ private:
     TukyUI::Components::TukyRotarySlider delaySlider,
         delaySyncSlider,
         feedbackSlider,
-        mixSlider;
+        mixSlider,
+        morphSlider;
 
     // Usings to make code more readable
     using APVTS = juce::AudioProcessorValueTreeState;
@@ -47,15 +49,17 @@ private:
     Attachment delaySliderAttachment,
         delaySyncSliderAttachment,
         feedbackSliderAttachment,
-        mixSliderAttachment;
+        mixSliderAttachment,
+        morphSliderAttachment;
 
     // Labels for sliders
     juce::Label delayLabel,
         feedbackLabel,
-        mixLabel;
+        mixLabel,
+        morphLabel;
 
     //Toggle Buttons 
-    TukyUI::Components::TukyToggleButton syncButton, pingPongButton;
+    TukyUI::Components::TukyToggleButton syncButton, pingPongButton, freezeButton, abButton;
 
 
     // Internal function to get references of all components declared before
@@ -92,5 +96,36 @@ private:
         }
     }
 
+    void freezeClicked()
+    {
+        audioProcessor.setFreeze(freezeButton.getToggleState());
+    }
+
+    void abClicked()
+    {
+        // A/B switch also changes modes, so buttons are refreshed from the processor
+        audioProcessor.switchPresetSlot(abButton.getToggleState() ? 1 : 0);
+        refreshButtons();
+    }
+
+    // Processor state changed (preset switch or state loaded)
+    void changeListenerCallback(juce::ChangeBroadcaster*) override
+    {
+        refreshButtons();
+    }
+
+    // Set toggles and delay slider from the processor state (modes live outside apvts)
+    void refreshButtons()
+    {
+        bool sync = audioProcessor.getMode() == audioProcessor.SYNC_MODE;
+        syncButton.setToggleState(sync, juce::dontSendNotification);
+        delaySlider.setVisible(!sync);
+        delaySyncSlider.setVisible(sync);
+
+        pingPongButton.setToggleState(audioProcessor.getPingPong(), juce::dontSendNotification);
+        freezeButton.setToggleState(audioProcessor.getFreeze(), juce::dontSendNotification);
+        abButton.setToggleState(audioProcessor.getPresetSlot() == 1, juce::dontSendNotification);
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TukTukyAudioProcessorEditor)
 };
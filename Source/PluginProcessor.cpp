@@ -24,10 +24,14 @@ TukTukyAudioProcessor::TukTukyAudioProcessor()
 {
     // We clear the buffer to avoid interferences with trash samples
     delayBuffer.clear();
+
+    // Picks up host program changes made off the message thread
+    startTimerHz(20);
 }
 
 TukTukyAudioProcessor::~TukTukyAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -70,22 +74,38 @@ double TukTukyAudioProcessor::getTailLengthSeconds() const
 
 int TukTukyAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // Programs are the A/B preset slots
+    return NUM_PRESETS;
 }
 
 int TukTukyAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return presetSlot;
 }
 
 void TukTukyAudioProcessor::setCurrentProgram (int index)
 {
+    // Hosts may change programs from the audio thread. There we only store the index,
+    // the switch itself runs on the message thread timer
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        switchPresetSlot(index);
+    }
+    else {
+        pendingProgram = index;
+    }
+}
+
+void TukTukyAudioProcessor::timerCallback()
+{
+    auto index = pendingProgram.exchange(-1);
+    if (index >= 0) {
+        switchPresetSlot(index);
+    }
 }
 
 const juce::String TukTukyAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return index == 0 ? "A" : "B";
 }
 
 void TukTukyAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -95,12 +115,23 @@ void TukTukyAudioProcessor::changeProgramName (int index, const juce::String& ne
 //==============================================================================
 void TukTukyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Set buffer size to 2 seconds
-    delayBufferSize = static_cast<int>((2.0 /* segundos */) * getSampleRate());
+    // Loop crossfade and freeze release take 10 ms
+    loopFadeSamples = juce::jmax(1, static_cast<int>(0.01 * getSampleRate()));
+
+    // Set buffer size to 2 seconds, plus room for the freeze loop crossfades
+    delayBufferSize = static_cast<int>((2.0 /* segundos */) * getSampleRate()) + 2 * loopFadeSamples;
     delayBuffer.setSize(2, delayBufferSize);
 
-    // Update params for the first iteration
+    // Any previous freeze loop is meaningless after a buffer resize
+    frozen = false;
+    freezeGain = 0.f;
+
+    // Update params for the first iteration, no morph pending
+    morphAmount = 1.f;
+    followingMorph = false;
+    morphDeferred = false;
     updateParams();
+    applyEngineParams(1.f);
 
     // We put the read pointer delay samples before for the first iteration
     readPtr = (writePtr - static_cast<int>(delayTime * getSampleRate()) + delayBufferSize) % delayBufferSize;
@@ -157,9 +188,32 @@ void TukTukyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    // A state was loaded, its params apply right away
+    if (morphCancelled.exchange(false))
+    {
+        followingMorph = false;
+        morphDeferred = false;
+        morphAmount = 1.f;
+    }
+
+    // Back to params once the morph is over and the message thread has written them all
+    if (followingMorph && morphAmount >= 1.f && !morphDeferred && !recallInProgress)
+    {
+        followingMorph = false;
+    }
+
     // We call update params each block in case something has change
     updateParams();
 
+    // Preset switch. This comes after updateParams: a recall only writes params after
+    // publishing its request, so params it already touched are overridden here
+    latchMorphRequest(sampleRate);
+
+    if (morphAmount >= 1.f)
+    {
+        applyEngineParams(1.f);
+    }
+
     // Temporal write pointe to keep the position at the beggining of this function
     // This variable is very important to write the samples of each channel from the right position
     //int tempWritePtr;
@@ -194,26 +248,99 @@ void TukTukyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
 
     int tempWritePtr = writePtr;
 
+    // Latch the freeze request once per block
+    bool freezeTarget = freeze;
+    float freezeStep = 1.f / loopFadeSamples;
 
     juce::Array<float*> channelData = { buffer.getWritePointer(0), buffer.getWritePointer(1) };
     juce::Array<float*> delayData = { delayBuffer.getWritePointer(0) , delayBuffer.getWritePointer(1) };
 
     for (int sample = 0; sample < numSamples; ++sample)
     {
+        // Morph runs per sample so levels glide instead of stepping
+        if (morphAmount < 1.f)
+        {
+            morphAmount = juce::jmin(1.f, morphAmount + morphStep);
+            applyEngineParams(morphAmount);
+        }
 
+        // Freeze engages instantly: the loop starts right where the delay was reading, so there is no jump.
+        // While a preset morph crossfades two taps that isn't true, so engaging waits for it to end.
+        // Releasing fades the loop out against the normal delay path, which starts writing again
+        if (freezeTarget)
+        {
+            if (!frozen && morphAmount >= 1.f)
+            {
+                loopLength = getLoopLength();
+                nextLoopLength = loopLength;
+                loopEnd = tempWritePtr;
+                loopPos = 0;
+                freezeGain = 1.f;
+                frozen = true;
+            }
+            else if (frozen)
+            {
+                freezeGain = juce::jmin(1.f, freezeGain + freezeStep);
+            }
+        }
+        else if (frozen)
+        {
+            freezeGain -= freezeStep;
+            if (freezeGain <= 0.f)
+            {
+                freezeGain = 0.f;
+                frozen = false;
+            }
+        }
 
-        for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-            // Calcular posiciones de lectura para ambos canales
-            int readPtr = (tempWritePtr - static_cast<int>(delayTime * getSampleRate()) + delayBufferSize) % delayBufferSize;
+        // Nothing is written once freeze holds the loop
+        bool holding = freezeTarget && frozen;
+
+        // Loop length follows the delay, but only changes at the loop point
+        if (frozen && loopLength - loopPos == loopFadeSamples)
+        {
+            nextLoopLength = getLoopLength();
+        }
 
-            // Recuperar muestras atrasadas
-            float delayedSample = delayData[channel][readPtr];
+        for (int channel = 0; channel < totalNumInputChannels; ++channel) {
+            float delayedSample;
 
+            if (frozen && freezeGain >= 1.f)
+            {
+                // Fully frozen: only read the loop and mix, write path is skipped
+                delayedSample = readLoop(delayData[channel]);
+            }
+            else
+            {
+                // Calcular posiciones de lectura para ambos canales
+                int readPtr = (tempWritePtr - static_cast<int>(delayTime * getSampleRate()) + delayBufferSize) % delayBufferSize;
+
+                // Recuperar muestras atrasadas
+                delayedSample = delayData[channel][readPtr];
+
+                // While morphing, the previous delay time keeps its own tap and fades out
+                if (morphAmount < 1.f)
+                {
+                    int morphReadPtr = wrapIndex(tempWritePtr - static_cast<int>(morphFrom.delayTime * getSampleRate()));
+                    delayedSample = morphAmount * delayedSample + (1.0f - morphAmount) * delayData[channel][morphReadPtr];
+                }
+
+                // Escribir en los buffers de delay con retroalimentacin cruzada
+                if (!holding)
+                {
+                    delayData[channel][tempWritePtr] = channelData[channel][sample] + feedback * delayedSample;
+                }
+
+                // Crossfade between delay and frozen loop while engaging/releasing
+                if (frozen)
+                {
+                    delayedSample = freezeGain * readLoop(delayData[channel]) + (1.0f - freezeGain) * delayedSample;
+                }
+            }
 
-            // Escribir en los buffers de delay con retroalimentacin cruzada
-            delayData[channel][tempWritePtr] = channelData[channel][sample] + feedback * delayedSample;
-            if (pingPong) {
-                delayedSample *= ramp(channel, pingPongCount);
+            // Ping pong amount is 0 or 1 except while morphing between presets
+            if (pingPongAmount > 0.f) {
+                delayedSample *= 1.0f + pingPongAmount * (ramp(channel, pingPongCount) - 1.0f);
             }
             channelData[channel][sample] = (1.0f - mix) * channelData[channel][sample] + mix * delayedSample;
 
@@ -225,8 +352,18 @@ void TukTukyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
             pingPongCount = 0;
         }
 
+        if (frozen && ++loopPos >= loopLength)
+        {
+            loopPos = 0;
+            loopLength = nextLoopLength;
+        }
+
         // Incrementar los punteros de lectura/escritura de manera circular
-        tempWritePtr = (tempWritePtr + 1) % delayBufferSize;
+        // While frozen nothing is written, so the write pointer stays at the loop end
+        if (!holding)
+        {
+            tempWritePtr = (tempWritePtr + 1) % delayBufferSize;
+        }
         
     }
 
@@ -246,22 +383,167 @@ juce::AudioProcessorEditor* TukTukyAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// State is a compact binary block:
+// magic, version, every apvts param (id + value), modes outside apvts and the A/B bank
 void TukTukyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt(STATE_MAGIC);
+    stream.writeInt(STATE_VERSION);
+
+    // Only ranged params have an id and a range to store
+    auto& params = getParameters();
+    int numParams = 0;
+    for (auto* param : params) {
+        if (dynamic_cast<juce::RangedAudioParameter*>(param) != nullptr) {
+            ++numParams;
+        }
+    }
+
+    stream.writeCompressedInt(numParams);
+    for (auto* param : params) {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param)) {
+            stream.writeString(ranged->paramID);
+            stream.writeFloat(ranged->convertFrom0to1(ranged->getValue()));
+        }
+    }
+
+    // Freeze is not saved: the buffer it loops isn't either
+    stream.writeCompressedInt(mode);
+    stream.writeBool(pingPong);
+
+    stream.writeCompressedInt(presetSlot);
+    for (int i = 0; i < NUM_PRESETS; ++i) {
+        stream.writeBool(presetStored[i]);
+        writePreset(stream, presets[i]);
+    }
 }
 
 void TukTukyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
 
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid()) {
-        apvts.replaceState(tree);
+    if (sizeInBytes < 8 || stream.readInt() != STATE_MAGIC) {
+        // Not our binary format, try a plain apvts ValueTree
+        auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+        if (tree.isValid()) {
+            apvts.replaceState(tree);
+        }
+        return;
+    }
+
+    // Unknown future layout, keep current state
+    auto version = stream.readInt();
+    if (version < 1 || version > STATE_VERSION) {
+        return;
     }
+
+    // Any morph request still waiting belongs to the state we are replacing
+    morphPending = -1;
+
+    // Params are matched by id, so added or removed params don't break old sessions
+    auto numParams = stream.readCompressedInt();
+    for (int i = 0; i < numParams && !stream.isExhausted(); ++i) {
+        auto id = stream.readString();
+        auto value = stream.readFloat();
+        if (auto* param = apvts.getParameter(id)) {
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        }
+    }
+
+    mode = juce::jlimit(NORMAL_MODE, SYNC_MODE, stream.readCompressedInt());
+    pingPong = stream.readBool();
+
+    presetSlot = juce::jlimit(0, NUM_PRESETS - 1, stream.readCompressedInt());
+    for (int i = 0; i < NUM_PRESETS; ++i) {
+        presetStored[i] = stream.readBool();
+        readPreset(stream, presets[i]);
+    }
+
+    // Stop a running morph from overriding the loaded params
+    morphCancelled = true;
+
+    // Let an open editor pick up the restored modes
+    sendChangeMessage();
+}
+
+//==============================================================================
+void TukTukyAudioProcessor::switchPresetSlot(int slot)
+{
+    if (slot == presetSlot || slot < 0 || slot >= NUM_PRESETS) {
+        return;
+    }
+
+    // Current sound goes into the slot we leave, an empty slot starts as a copy of it
+    presets[presetSlot] = capturePreset();
+    presetStored[presetSlot] = true;
+    if (!presetStored[slot]) {
+        presets[slot] = presets[presetSlot];
+        presetStored[slot] = true;
+    }
+
+    presetSlot = slot;
+    recallPreset(presets[slot]);
+    sendChangeMessage();
+}
+
+TukTukyAudioProcessor::Preset TukTukyAudioProcessor::capturePreset()
+{
+    Preset preset;
+    for (int i = 0; i < NUM_PRESET_PARAMS; ++i) {
+        preset.values[i] = apvts.getRawParameterValue(PRESET_PARAMS[i])->load();
+    }
+    preset.mode = mode;
+    preset.pingPong = pingPong;
+    return preset;
+}
+
+void TukTukyAudioProcessor::recallPreset(const Preset& preset)
+{
+    // Publish the complete preset first. The audio thread latches it together with the morph
+    // request and follows it until recallInProgress is cleared, so the param writes below
+    // can land in any order without the engine seeing half of them
+    recallInProgress = true;
+    morphPresets[morphWriteSlot] = preset;
+    morphPending = morphWriteSlot;
+    morphWriteSlot = 1 - morphWriteSlot;
+
+    for (int i = 0; i < NUM_PRESET_PARAMS; ++i) {
+        if (auto* param = apvts.getParameter(PRESET_PARAMS[i])) {
+            param->beginChangeGesture();
+            param->setValueNotifyingHost(param->convertTo0to1(preset.values[i]));
+            param->endChangeGesture();
+        }
+    }
+
+    mode = preset.mode;
+    pingPong = preset.pingPong;
+    recallInProgress = false;
+}
+
+void TukTukyAudioProcessor::writePreset(juce::OutputStream& stream, const Preset& preset) const
+{
+    stream.writeCompressedInt(NUM_PRESET_PARAMS);
+    for (auto value : preset.values) {
+        stream.writeFloat(value);
+    }
+    stream.writeCompressedInt(preset.mode);
+    stream.writeBool(preset.pingPong);
+}
+
+void TukTukyAudioProcessor::readPreset(juce::InputStream& stream, Preset& preset) const
+{
+    // Values beyond the ones we know are skipped
+    auto numValues = stream.readCompressedInt();
+    for (int i = 0; i < numValues && !stream.isExhausted(); ++i) {
+        auto value = stream.readFloat();
+        if (i < NUM_PRESET_PARAMS) {
+            preset.values[i] = value;
+        }
+    }
+    preset.mode = juce::jlimit(NORMAL_MODE, SYNC_MODE, stream.readCompressedInt());
+    preset.pingPong = stream.readBool();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout TukTukyAudioProcessor::createParameterLayout() {
@@ -271,16 +553,29 @@ juce::AudioProcessorValueTreeState::ParameterLayout TukTukyAudioProcessor::creat
     layout.add(std::make_unique<juce::AudioParameterInt>("Delay Sync", "Delay Sync", 0, 6, 6));
     layout.add(std::make_unique<juce::AudioParameterFloat>("Feedback", "Feedback", juce::NormalisableRange<float>(0.f, 1.f, 0.05f, 1.f), 0.5f));
     layout.add(std::make_unique<juce::AudioParameterFloat>("Mix", "Mix", juce::NormalisableRange<float>(0.f, 1.f, 0.05f, 1.f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Morph", "Morph", juce::NormalisableRange<float>(0.f, 2.f, 0.01f, 1.f), 0.05f));
 
     return layout;
 }
 
 // In this function we only update params value if GUI has changed on some way
+// While a preset morph is running, the latched preset is followed instead
 void TukTukyAudioProcessor::updateParams() {
-    switch (mode)
+    setTargets(followingMorph ? morphPreset : capturePreset());
+}
+
+void TukTukyAudioProcessor::setTargets(const Preset& preset) {
+    target = getEngineTargets(preset);
+}
+
+// Preset values are in PRESET_PARAMS order. Without a playhead, sync keeps the current delay
+TukTukyAudioProcessor::EngineParams TukTukyAudioProcessor::getEngineTargets(const Preset& preset) {
+    EngineParams next = target;
+
+    switch (preset.mode)
     {
     case 0:
-        delayTime = apvts.getRawParameterValue("Delay")->load();
+        next.delayTime = preset.values[0];
         break;
     case 1:
         if (auto* playHead = getPlayHead()) {
@@ -292,14 +587,59 @@ void TukTukyAudioProcessor::updateParams() {
             {
                 // Accedemos al BPM actual
                 auto bpm = positionInfo.bpm;
-                delayTime = bpm / 60.f * SYNC_FRAC[apvts.getRawParameterValue("Delay Sync")->load()];
+                next.delayTime = bpm / 60.f * SYNC_FRAC[static_cast<int>(preset.values[1])];
             }
         }
     default:
         break;
     }
-    mix = apvts.getRawParameterValue("Mix")->load();
-    feedback = apvts.getRawParameterValue("Feedback")->load();
+    next.feedback = preset.values[2];
+    next.mix = preset.values[3];
+    next.pingPong = preset.pingPong ? 1.f : 0.f;
+    return next;
+}
+
+// Take a published preset request (or the one waiting for the running morph) and start morphing.
+// Only two delay taps exist, so while a morph runs a request can only reverse it; anything else
+// waits until the morph ends, so no tap is ever dropped with weight left
+void TukTukyAudioProcessor::latchMorphRequest(double sampleRate) {
+    auto pending = morphPending.exchange(-1);
+    if (pending >= 0)
+    {
+        deferredPreset = morphPresets[pending];
+        morphDeferred = true;
+    }
+
+    if (!morphDeferred)
+    {
+        return;
+    }
+
+    auto next = getEngineTargets(deferredPreset);
+
+    if (morphAmount >= 1.f)
+    {
+        // Morph from what the engine is using right now
+        morphFrom = { delayTime, feedback, mix, pingPongAmount };
+        morphAmount = 0.f;
+        morphStep = 1.f / juce::jmax(1.f, static_cast<float>(apvts.getRawParameterValue("Morph")->load() * sampleRate));
+    }
+    else if (next == morphFrom)
+    {
+        // Going back to where the morph started: run it backwards from the same point
+        morphFrom = target;
+        morphAmount = 1.f - morphAmount;
+    }
+    else if (!(next == target))
+    {
+        // Keep following the running morph until it ends
+        return;
+    }
+
+    target = next;
+    morphPreset = deferredPreset;
+    followingMorph = true;
+    morphDeferred = false;
 }
 //==============================================================================
 // This creates new instances of the plugin..
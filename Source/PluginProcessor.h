@@ -13,7 +13,9 @@
 //==============================================================================
 /**
 */
-class TukTukyAudioProcessor  : public juce::AudioProcessor
+class TukTukyAudioProcessor  : public juce::AudioProcessor,
+                               public juce::ChangeBroadcaster,
+                               private juce::Timer
 {
 public:
     //==============================================================================
@@ -78,13 +80,101 @@ public:
 
     void setMode(int m) {
         mode = m;
-        updateParams();
     }
 
     void setPingPong(bool set) {
         pingPong = set;
     }
+
+    void setFreeze(bool set) {
+        freeze = set;
+    }
+
+    bool getFreeze() const { return freeze; }
+
+    int getMode() const { return mode; }
+    bool getPingPong() const { return pingPong; }
+
+    // A/B preset bank. Switching stores the current sound into the active slot
+    // and morphs to the other one
+    static constexpr int NUM_PRESETS = 2;
+    int getPresetSlot() const { return presetSlot; }
+    void switchPresetSlot(int slot);
 private:
+    // Binary state header
+    static constexpr int STATE_MAGIC = 0x6b546b54; // "TkTk"
+    static constexpr int STATE_VERSION = 1;
+
+    // Params captured by presets ("Morph" is a global setting, not part of a preset)
+    static constexpr int NUM_PRESET_PARAMS = 4;
+    const juce::StringArray PRESET_PARAMS = { "Delay", "Delay Sync", "Feedback", "Mix" };
+
+    // Fixed size so presets can be copied anywhere without allocating
+    struct Preset {
+        std::array<float, NUM_PRESET_PARAMS> values{};
+        int mode = 0;
+        bool pingPong = false;
+    };
+
+    Preset capturePreset();
+    void recallPreset(const Preset& preset);
+    void writePreset(juce::OutputStream& stream, const Preset& preset) const;
+    void readPreset(juce::InputStream& stream, Preset& preset) const;
+
+    Preset presets[NUM_PRESETS];
+    bool presetStored[NUM_PRESETS] = {};
+    std::atomic<int> presetSlot{ 0 };
+
+    // Host program changes off the message thread are polled by a message thread timer
+    std::atomic<int> pendingProgram{ -1 };
+    void timerCallback() override;
+
+    // Morph target handover. The message thread fills one slot of the double buffer
+    // and publishes its index; the audio thread latches it as the morph request
+    Preset morphPresets[2];
+    int morphWriteSlot = 0;
+    std::atomic<int> morphPending{ -1 };
+    std::atomic<bool> recallInProgress{ false };
+
+    // State loaded: drop any running morph and jump to the loaded params
+    std::atomic<bool> morphCancelled{ false };
+
+    // Audio thread: latched preset, followed until the morph ends and params are in sync.
+    // A request that can't take over the running morph waits in deferredPreset
+    Preset morphPreset, deferredPreset;
+    bool followingMorph = false;
+    bool morphDeferred = false;
+
+    // Values the engine is heading to (set from params and modes)
+    struct EngineParams {
+        float delayTime = 0.5f;
+        float feedback = 0.5f;
+        float mix = 0.5f;
+        float pingPong = 0.f;
+
+        bool operator== (const EngineParams& other) const {
+            return delayTime == other.delayTime && feedback == other.feedback
+                && mix == other.mix && pingPong == other.pingPong;
+        }
+    };
+
+    EngineParams target, morphFrom;
+    EngineParams getEngineTargets(const Preset& preset);
+    void latchMorphRequest(double sampleRate);
+
+    float morphAmount = 1.f;
+    float morphStep = 1.f;
+
+    // Move engine values between morphFrom and target. Delay time is not interpolated:
+    // while morphing, the old delay keeps its own read tap and is crossfaded out
+    // Written so amount 0 and 1 give exactly morphFrom and target
+    void applyEngineParams(float amount) {
+        delayTime = target.delayTime;
+        feedback = (1.0f - amount) * morphFrom.feedback + amount * target.feedback;
+        mix = (1.0f - amount) * morphFrom.mix + amount * target.mix;
+        pingPongAmount = (1.0f - amount) * morphFrom.pingPong + amount * target.pingPong;
+    }
+
     float ramp(int channel, int x) {
 
         int td = static_cast<int>(delayTime * getSampleRate());
@@ -123,6 +213,35 @@ private:
         }
         return y;
     }
+
+    // Wrap any (possibly negative) position into the delay buffer
+    int wrapIndex(int i) const {
+        return ((i % delayBufferSize) + delayBufferSize) % delayBufferSize;
+    }
+
+    // Loop length in samples for the current delay (or sync division)
+    // The buffer has headroom for the crossfade pre-roll and the release write-ahead,
+    // so the clamp only kicks in for delays longer than the buffer was sized for
+    int getLoopLength() {
+        int length = static_cast<int>(delayTime * getSampleRate());
+        return juce::jlimit(2 * loopFadeSamples, delayBufferSize - 2 * loopFadeSamples, length);
+    }
+
+    // Read the frozen loop at loopPos. Over the last loopFadeSamples we crossfade into
+    // the samples leading up to the next loop start, so the wrap lands on continuous audio
+    float readLoop(const float* data) const {
+        int remaining = loopLength - loopPos;
+        float y = data[wrapIndex(loopEnd - loopLength + loopPos)];
+
+        if (remaining <= loopFadeSamples)
+        {
+            float t = static_cast<float>(remaining) / loopFadeSamples;
+            float next = data[wrapIndex(loopEnd - nextLoopLength - remaining)];
+            y = t * y + (1.0f - t) * next;
+        }
+        return y;
+    }
+
     //Delay buffer, delay buffer size
     juce::AudioBuffer<float> delayBuffer;
     int delayBufferSize = 0;
@@ -137,14 +256,28 @@ private:
     float mix = 0.5;
 
 
-    int mode = NORMAL_MODE;
+    // Modes are written on the message thread and read on the audio thread
+    std::atomic<int> mode{ NORMAL_MODE };
 
 
     int pingPongChannel = 0;
     int pingPongCount = 0;
-    bool pingPong = false;
+    std::atomic<bool> pingPong{ false };
+    float pingPongAmount = 0.f;
+
+    // Freeze: requested state (GUI) and loop state (audio thread)
+    std::atomic<bool> freeze{ false };
+    bool frozen = false;
+    float freezeGain = 0.f;
+    int loopEnd = 0;
+    int loopLength = 0;
+    int nextLoopLength = 0;
+    int loopPos = 0;
+    int loopFadeSamples = 1;
+
     // Function to update params
     void updateParams();
+    void setTargets(const Preset& preset);
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TukTukyAudioProcessor)
 };